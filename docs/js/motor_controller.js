@@ -1,3 +1,8 @@
+// serial_worker.js อยู่โฟลเดอร์เดียวกับไฟล์นี้ (ต้องจับ path ตอนโหลด script)
+const SERIAL_WORKER_URL = document.currentScript
+  ? new URL("serial_worker.js", document.currentScript.src).href
+  : "js/serial_worker.js";
+
 class MotorController {
   constructor() {
     this.port = null;
@@ -10,6 +15,18 @@ class MotorController {
     this.onRawData = null;
     this.isConnected = false;
     this._internalListeners = [];
+    this.debug = false; // true = log ทุก JSON ที่รับมา (ช้ามากตอน Status ถี่ๆ)
+
+    // --- Serial Worker (อ่าน/parse นอก UI thread) ---
+    this.worker = null;
+    this.maxBacklog = 500; // จำนวนบรรทัดสูงสุดที่ค้างใน Worker ก่อนเริ่มทิ้ง Telemetry เก่า
+    this.rxStats = null; // { lines, parsed, parseErrors, dropped, overflow, coalesced }
+    this.onRxStats = null;
+    this._pendingBatches = [];
+    this._frameRequested = false;
+    this._frameToken = 0;
+    this._coalesced = 0;
+    this._workerClosed = null; // resolver ตอนรอ Worker ปิด reader
 
     // --- Queue System ---
     this.commandQueue = [];
@@ -32,6 +49,18 @@ class MotorController {
     this.toolRefreshInterval = null; // Interval สำหรับ refresh
     this.onToolUpdate = null; // Callback เมื่อ Tool อัพเดท
     this._pendingToolQuery = null; // Promise resolver สำหรับรอ response
+
+    // ===== Jog (Velocity Mode) =====
+    this.jogKeepAliveMs = 100; // ต้องน้อยกว่า Deadman timeout ของ Firmware (jt)
+    this.jogStopTimeoutMs = 5000; // ส่ง j0 ซ้ำนานสุดเท่านี้ ถ้ายังไม่ได้ 215
+    this._jogPending = {}; // motorId -> speed ล่าสุดที่ยังไม่ได้ส่ง
+    this._jogActive = {}; // motorId ที่ UI ยังกด Jog อยู่ -> ส่ง keep-alive เฉพาะแกนนี้
+    this._jogStopping = {}; // motorId -> เวลาที่สั่ง j0 (รอ 215 / 213 ยืนยัน)
+    this._jogSending = false;
+    this._jogTimer = null;
+
+    // ทุกการเขียนลง Serial ต่อคิวผ่าน Promise นี้ (กัน getWriter() ชนกัน)
+    this._writeChain = Promise.resolve();
   }
 
   async connect() {
@@ -52,6 +81,9 @@ class MotorController {
   }
 
   async disconnect() {
+    if (this.worker) {
+      await this._stopWorkerReader();
+    }
     if (this.reader) {
       await this.reader.cancel();
       this.reader = null;
@@ -68,6 +100,9 @@ class MotorController {
   }
 
   async readLoop() {
+    if (this._startWorkerReader()) return;
+
+    // Fallback: Browser ที่ไม่รองรับ Worker / transferable streams อ่านบน UI thread แบบเดิม
     while (this.port.readable && this.isConnected) {
       this.reader = this.port.readable.getReader();
       try {
@@ -84,6 +119,121 @@ class MotorController {
       }
     }
   }
+  /**
+   * Transfer port.readable to the serial worker. Returns false if this browser
+   * cannot (no Worker or no transferable streams) so readLoop falls back.
+   */
+  _startWorkerReader() {
+    if (typeof Worker === "undefined") return false;
+
+    try {
+      if (!this.worker) {
+        this.worker = new Worker(SERIAL_WORKER_URL);
+        this.worker.onmessage = (e) => this._onWorkerMessage(e.data);
+      }
+      const readable = this.port.readable;
+      this.worker.postMessage(
+        { type: "start", readable, maxBacklog: this.maxBacklog },
+        [readable]
+      );
+      this._setExpectations(this.currentExpectations);
+      return true;
+    } catch (error) {
+      console.warn("Serial worker unavailable, reading on main thread:", error);
+      if (this.worker) this.worker.terminate();
+      this.worker = null;
+      return false;
+    }
+  }
+
+  async _stopWorkerReader() {
+    const closed = new Promise((resolve) => (this._workerClosed = resolve));
+    this.worker.postMessage({ type: "stop" });
+    await closed;
+    this.worker.terminate();
+    this.worker = null;
+    this._pendingBatches = [];
+    this._coalesced = 0;
+  }
+
+  _onWorkerMessage(msg) {
+    switch (msg.type) {
+      case "batch":
+        this._pendingBatches.push(msg.items);
+        this.rxStats = msg.stats;
+        this._requestFrame();
+        break;
+      case "error":
+        console.error("Read error:", msg.message);
+        break;
+      case "closed":
+        if (this._workerClosed) {
+          this._workerClosed();
+          this._workerClosed = null;
+        } else if (this.isConnected && this.port?.readable) {
+          // Reader หลุด (เช่น framing error) -> เปิดใหม่เหมือน readLoop เดิม
+          this._startWorkerReader();
+        }
+        break;
+    }
+  }
+
+  // รวมทุก batch ที่มาใน 1 เฟรม แล้วประมวลผลทีเดียว
+  // - แท็บซ่อนอยู่: rAF ไม่ทำงาน -> ใช้ MessageChannel (ไม่โดน throttle แบบ setTimeout)
+  // - แท็บแสดงอยู่: rAF + setTimeout สำรอง เผื่อแท็บถูกซ่อนหลังจากขอ rAF ไปแล้ว
+  _requestFrame() {
+    if (this._frameRequested) return;
+    this._frameRequested = true;
+
+    const token = ++this._frameToken;
+    let fallback = null;
+    const run = () => {
+      if (token !== this._frameToken || !this._frameRequested) return;
+      clearTimeout(fallback);
+      this._processBatches();
+    };
+
+    if (typeof document !== "undefined" && document.hidden) {
+      const channel = new MessageChannel();
+      channel.port1.onmessage = run;
+      channel.port2.postMessage(null);
+    } else {
+      requestAnimationFrame(run);
+      fallback = setTimeout(run, 100);
+    }
+  }
+
+  _processBatches() {
+    this._frameRequested = false;
+    const batches = this._pendingBatches;
+    this._pendingBatches = [];
+
+    const items = batches.length === 1 ? batches[0] : batches.flat();
+
+    // Telemetry หลายอันของมอเตอร์ตัวเดียวกันในเฟรมเดียว: แจ้ง UI แค่อันล่าสุด
+    const latest = {};
+    items.forEach((item, i) => {
+      const name = item.telemetry && (item.data?.motor || item.data?.motorName);
+      if (name) latest[name] = i;
+    });
+
+    items.forEach((item, i) => {
+      if (item.parseError) console.warn("Parse error", item.raw);
+      const name = item.telemetry && (item.data?.motor || item.data?.motorName);
+      const superseded = name && latest[name] !== i;
+      if (superseded) this._coalesced++;
+      this._handleLine(item.raw, item.data, superseded);
+    });
+
+    if (this.worker) this.worker.postMessage({ type: "ack" });
+    if (this.rxStats) this.rxStats.coalesced = this._coalesced;
+    if (this.onRxStats && this.rxStats) this.onRxStats(this.rxStats);
+  }
+
+  getRxStats() {
+    return this.rxStats;
+  }
+
   // เพิ่มฟังก์ชันนี้ลงใน Class MotorController
   async waitForIdle() {
     console.log("Waiting for motors to be IDLE...");
@@ -116,63 +266,87 @@ class MotorController {
       const trimmedLine = line.trim();
       if (trimmedLine === "") continue;
 
-      if (this.onRawData) this.onRawData(trimmedLine);
-
+      let data = null;
       if (trimmedLine.startsWith("{")) {
         try {
-          const data = JSON.parse(trimmedLine);
-          
-          // 🔍 Debug: Log all parsed JSON
-          console.log("[RX]", data);
-
-          // ✅ เพิ่มตรงนี้: อัปเดตสถานะล่าสุดเก็บไว้
-          if (data.motor || data.motorName) {
-            const name = data.motor || data.motorName;
-            // เช็คเผื่อชื่อมาแปลกๆ หรือ map ให้ตรงกับ key
-            if (this.motorStates[name]) {
-              this.motorStates[name] = { ...this.motorStates[name], ...data };
+          data = JSON.parse(trimmedLine);
+        } catch (e) {
+          console.warn("Parse error", e, trimmedLine);
+        }
+      }
+      this._handleLine(trimmedLine, data);
+    }
+  }
+
+  /**
+   * Dispatch one received line (already parsed by the worker or handleData).
+   * superseded = newer telemetry for the same motor arrived in this frame:
+   * state and queue are still updated, but UI callbacks are skipped.
+   */
+  _handleLine(trimmedLine, data, superseded = false) {
+    if (this.onRawData && !superseded) this.onRawData(trimmedLine);
+
+    if (data) {
+      try {
+        // 🔍 Debug: Log all parsed JSON
+        if (this.debug) console.log("[RX]", data);
+
+        // ✅ เพิ่มตรงนี้: อัปเดตสถานะล่าสุดเก็บไว้
+        if (data.motor || data.motorName) {
+          const name = data.motor || data.motorName;
+          // เช็คเผื่อชื่อมาแปลกๆ หรือ map ให้ตรงกับ key
+          if (this.motorStates[name]) {
+            this.motorStates[name] = { ...this.motorStates[name], ...data };
+            if (data.code === 214) this.motorStates[name].jogging = true;
+            if (data.code === 215 || data.code === 213) {
+              this.motorStates[name].jogging = false;
+              delete this._jogStopping[name.replace("Motor", "")];
+            }
+            // Jog ถูกปฏิเสธ (ลิมิต / มี Move อยู่) -> เลิกส่ง keep-alive ให้แกนนี้
+            if (data.code === 413 || data.code === 416) {
+              delete this._jogActive[name.replace("Motor", "")];
             }
           }
-          if (this.onData) this.onData(data);
+        }
+        if (this.onData && !superseded) this.onData(data);
 
-          // ===== Handle AUX Tool Response =====
-          // Case 1: Wrapped response { type: "AUX", message: "..." }
-          if (data.type === "AUX") {
-            this._handleAuxResponse(data);
-          }
-          
-          // Case 2: Direct tool query response (m?) - has "commands" array
-          // Tool ส่ง {"type":"INFO","code":101,"name":"...","commands":[...]}
-          if (data.commands && Array.isArray(data.commands)) {
-            console.log("[Direct Tool Query Response]", data);
-            this._handleAuxResponse(data); // Use same handler
-          }
-          
-          // Case 3: Direct response from tool command (not wrapped)
-          // Tool ส่งตรงๆ เช่น {"type":"SUCCESS","code":201,...}
-          // ตรวจสอบว่าเป็น response จาก tool โดยดู code range (100-402 คือ Torom codes)
-          // และต้องไม่ใช่ motor response (motor response มี motor field)
-          if (data.code && data.code >= 100 && data.code <= 402 && 
-              data.type !== "AUX" && !data.motor && !data.motorName) {
-            // ถ้ากำลังรอ AUX response อยู่ ให้ถือว่าเป็น tool response
-            if (this.currentExpectations?.type === "AUX") {
-              console.log("[AUX Direct Command Response]", data);
-              this._checkQueueExpectationsForAux(data);
-            }
+        // ===== Handle AUX Tool Response =====
+        // Case 1: Wrapped response { type: "AUX", message: "..." }
+        if (data.type === "AUX") {
+          this._handleAuxResponse(data);
+        }
+        
+        // Case 2: Direct tool query response (m?) - has "commands" array
+        // Tool ส่ง {"type":"INFO","code":101,"name":"...","commands":[...]}
+        if (data.commands && Array.isArray(data.commands)) {
+          console.log("[Direct Tool Query Response]", data);
+          this._handleAuxResponse(data); // Use same handler
+        }
+        
+        // Case 3: Direct response from tool command (not wrapped)
+        // Tool ส่งตรงๆ เช่น {"type":"SUCCESS","code":201,...}
+        // ตรวจสอบว่าเป็น response จาก tool โดยดู code range (100-402 คือ Torom codes)
+        // และต้องไม่ใช่ motor response (motor response มี motor field)
+        if (data.code && data.code >= 100 && data.code <= 402 && 
+            data.type !== "AUX" && !data.motor && !data.motorName) {
+          // ถ้ากำลังรอ AUX response อยู่ ให้ถือว่าเป็น tool response
+          if (this.currentExpectations?.type === "AUX") {
+            console.log("[AUX Direct Command Response]", data);
+            this._checkQueueExpectationsForAux(data);
           }
+        }
 
-          // --- Logic การเช็ค Response เพื่อปลดล็อค Queue ---
-          this._checkQueueExpectations(data);
+        // --- Logic การเช็ค Response เพื่อปลดล็อค Queue ---
+        this._checkQueueExpectations(data);
 
-          // Handle internal listeners (for manual waits if needed)
-          if (this._internalListeners.length > 0) {
-            this._internalListeners = this._internalListeners.filter(
-              (l) => !l(data)
-            );
-          }
-        } catch (e) {
-          console.warn("Parse error", e, trimmedLine);
+        // Handle internal listeners (for manual waits if needed)
+        if (this._internalListeners.length > 0) {
+          this._internalListeners = this._internalListeners.filter(
+            (l) => !l(data)
+          );
         }
+      } catch (e) {
+        console.warn("Handler error", e, trimmedLine);
       }
     }
   }
@@ -230,7 +404,7 @@ class MotorController {
     }
 
     // 1. Error Codes (Fatal) - อันนี้คงเดิม
-    if (code === 406 || code === 407 || code === 403 || code === 400 || code === 401 || code === 402) {
+    if (code === 406 || code === 407 || code === 408 || code === 409 || code === 403 || code === 400 || code === 401 || code === 402) {
       this.currentCmdPromise.reject(
         new Error(`Device Error: ${data.message} (Code ${code})`)
       );
@@ -241,6 +415,10 @@ class MotorController {
     // ถ้าเป็นคำสั่ง MOVE ให้ถือว่า 211(ถึง), 212(สั่งหยุด), 213(ชนลิมิต) คือ "จบงานของมอเตอร์ตัวนั้น"
     const isMoveFinish =
       exp.type === "MOVE" && (code === 211 || code === 212 || code === 213);
+
+    // Shaper test move ที่ถูกสั่งหยุด / E-Stop / ชนลิมิต จะไม่มี 223 ตามมา
+    const isCalibAbort =
+      exp.type === "SHAPER_CALIB" && (code === 212 || code === 213);
     
     // AUX Tool: 200 (SUCCESS), 201 (TARGET_REACHED) คือเสร็จ
     const isAuxFinish =
@@ -249,7 +427,7 @@ class MotorController {
     // ถ้าเป็นคำสั่งอื่น ดูตามโพยที่จดมา
     const isExpected = exp.codes.includes(code);
 
-    if (isMoveFinish || isAuxFinish || isExpected) {
+    if (isMoveFinish || isCalibAbort || isAuxFinish || isExpected) {
       // ลดจำนวนที่ต้องรอลง 1 แต้ม
       exp.count--;
 
@@ -260,16 +438,32 @@ class MotorController {
     }
   }
 
+  /**
+   * Write one command line. All writes (queue, immediate, jog) go through one
+   * promise chain so only one getWriter() lock is ever held. Rejects on error.
+   */
+  _write(command) {
+    const run = async () => {
+      if (!this.port || !this.port.writable) throw new Error("Port not writable");
+      const writer = this.port.writable.getWriter();
+      try {
+        const cmdToSend = command.endsWith("\n") ? command : command + "\n";
+        await writer.write(this.encoder.encode(cmdToSend));
+      } finally {
+        writer.releaseLock();
+      }
+    };
+    const result = this._writeChain.then(run, run);
+    this._writeChain = result.catch(() => {});
+    return result;
+  }
+
   async sendImmediate(command) {
     if (!this.port || !this.port.writable) return;
 
     try {
-      // 1. แย่งกุญแจ (Writer) มาเลย เพราะ Web Serial ยอมให้เขียนได้
-      // แม้ว่าจะมีคำสั่งอื่นรอ Response อยู่ (ตราบใดที่คำสั่งนั้นเขียนเสร็จไปแล้ว)
-      const writer = this.port.writable.getWriter();
-      const cmdToSend = command.endsWith("\n") ? command : command + "\n";
-      await writer.write(this.encoder.encode(cmdToSend));
-      writer.releaseLock();
+      // 1. ไม่เข้าคิวคำสั่ง (ไม่รอ Response ของคำสั่งก่อนหน้า) แต่ยังต่อคิวการเขียนใน _write
+      await this._write(command);
 
       // 2. ถ้าเป็นคำสั่ง STOP (s) หรือ EMERGENCY (e) ต้องล้างคิวทิ้งด้วย!
       // เพราะถ้าเราสั่งหยุดแล้ว คำสั่ง Move ที่รอคิวอยู่ก็ไม่ควรทำต่อแล้ว
@@ -351,6 +545,58 @@ class MotorController {
     await this.send(`i${ratio}`);
   }
 
+  // Input Shaper: type = "off" | "zv" | "zvd" | "ei"
+  async setInputShaper(type, motorId = 0) {
+    if (motorId === 0) await this.send(`zt${type}`);
+    else await this.send(`${motorId}:zt${type}`);
+  }
+  async setShaperFrequency(hz, motorId = 0) {
+    if (motorId === 0) await this.send(`zf${hz}`);
+    else await this.send(`${motorId}:zf${hz}`);
+  }
+  async setShaperDamping(zeta, motorId = 0) {
+    if (motorId === 0) await this.send(`zd${zeta}`);
+    else await this.send(`${motorId}:zd${zeta}`);
+  }
+  async getShaperStatus(motorId = 0) {
+    if (motorId === 0) await this.send("z");
+    else await this.send(`${motorId}:z`);
+  }
+  // Test move สำหรับวัด Ringing -> คืนค่า { moveStartMs, moveEndMs, ... } จาก Code 223
+  async shaperCalibrationMove(motorId, steps) {
+    return await this.send(`${motorId}:zc${steps}`);
+  }
+
+  // Multi-board Sync: arm ไว้ก่อน แล้วค่อยสั่งออกตัวพร้อมกันทุกบอร์ด
+  async armMove(motorId, position) {
+    await this.send(`${motorId}:g${position}`);
+  }
+  async armAll(x, y, z = 0) {
+    await this.send(`g${x},${y},${z}`);
+  }
+  async syncStartOnEdge() {
+    await this.send("gs");
+  }
+  async syncStartAt(syncTimeUs) {
+    await this.send(`gt${syncTimeUs}`);
+  }
+  // คืนค่า { trigger, startSyncUs, skewUs } จาก Code 233
+  async syncStartNow() {
+    return await this.send("gg");
+  }
+  async cancelArmed() {
+    await this.send("gc");
+  }
+  async zeroSyncClock() {
+    await this.send("gz");
+  }
+  async setSyncPeriod(periodUs) {
+    await this.send(`gp${periodUs}`);
+  }
+  async getSyncStatus() {
+    return await this.send("gq");
+  }
+
   // กลุ่ม 2: คำสั่ง VVIP (แซงคิวทันที!) 🚀
   async stop(motorId = 0) {
     if (motorId === 0) await this.sendImmediate("s");
@@ -362,6 +608,96 @@ class MotorController {
     else await this.sendImmediate(`${motorId}:e`);
   }
 
+  // Jog: ไม่เข้าคิวคำสั่ง และรวมคำสั่งที่มาถี่ๆ ให้เหลือค่าล่าสุดต่อแกน
+  // speed หน่วย rev/s มีเครื่องหมาย, 0 = ชะลอจนหยุด (ส่งซ้ำจนได้ 215 ยืนยัน)
+  jog(motorId, speed) {
+    const id = String(motorId);
+    this._jogPending[id] = speed;
+    if (speed === 0) {
+      delete this._jogActive[id];
+      this._jogStopping[id] = Date.now();
+    } else {
+      this._jogActive[id] = true;
+      delete this._jogStopping[id];
+    }
+    this._flushJog();
+
+    if (!this._jogTimer) {
+      this._jogTimer = setInterval(() => this._jogTick(), this.jogKeepAliveMs);
+    }
+  }
+
+  stopJog(motorId) {
+    this.jog(motorId, 0);
+  }
+
+  stopJogKeepAlive() {
+    if (this._jogTimer) {
+      clearInterval(this._jogTimer);
+      this._jogTimer = null;
+    }
+  }
+
+  async setJogTimeout(ms) {
+    await this.send(`jt${ms}`);
+  }
+
+  async _flushJog() {
+    if (this._jogSending) return;
+    this._jogSending = true;
+    try {
+      let ids = Object.keys(this._jogPending);
+      while (ids.length > 0) {
+        for (const id of ids) {
+          const speed = this._jogPending[id];
+          delete this._jogPending[id];
+          try {
+            await this._write(`${id}:j${speed}`);
+          } catch (error) {
+            // เขียนไม่สำเร็จ -> เก็บไว้ส่งใหม่รอบ _jogTick ถัดไป (ถ้ายังไม่มีค่าใหม่กว่า)
+            console.error("Jog send error:", error);
+            if (!(id in this._jogPending)) this._jogPending[id] = speed;
+            return;
+          }
+        }
+        ids = Object.keys(this._jogPending);
+      }
+    } finally {
+      this._jogSending = false;
+    }
+  }
+
+  // ทุก jogKeepAliveMs: ส่ง j0 ซ้ำให้แกนที่ยังไม่ยืนยันหยุด และ keep-alive เฉพาะแกนที่ยังกดอยู่
+  async _jogTick() {
+    const now = Date.now();
+    for (const id of Object.keys(this._jogStopping)) {
+      if (now - this._jogStopping[id] > this.jogStopTimeoutMs) {
+        console.error(`Jog stop not confirmed for motor ${id}`);
+        delete this._jogStopping[id];
+      } else if (!(id in this._jogPending)) {
+        this._jogPending[id] = 0;
+      }
+    }
+
+    const active = Object.keys(this._jogActive);
+    if (
+      active.length === 0 &&
+      Object.keys(this._jogStopping).length === 0 &&
+      Object.keys(this._jogPending).length === 0
+    ) {
+      this.stopJogKeepAlive();
+      return;
+    }
+
+    await this._flushJog();
+    for (const id of active) {
+      if (!this._jogActive[id] || id in this._jogPending) continue;
+      this._write(`${id}:k`).catch((error) =>
+        console.error("Jog keep-alive error:", error)
+      );
+    }
+  }
+
   // Status (d) อยากให้อัปเดตทันที ไม่ต้องรอคิว Move เสร็จ
   async getDetailedStatus(motorId = 0) {
     if (motorId === 0) await this.sendImmediate("d");
@@ -389,15 +725,11 @@ class MotorController {
           this._finishCommand(currentItem, "error", err);
         },
       };
-      this.currentExpectations = currentItem.expectations;
+      // ต้องแจ้ง Worker ก่อนเขียนคำสั่ง เพื่อให้ Reply ที่ตามมาไม่ถูกทิ้ง
+      this._setExpectations(currentItem.expectations);
 
       // ส่งข้อมูลออกไป
-      const writer = this.port.writable.getWriter();
-      const cmdToSend = currentItem.command.endsWith("\n")
-        ? currentItem.command
-        : currentItem.command + "\n";
-      await writer.write(this.encoder.encode(cmdToSend));
-      writer.releaseLock();
+      await this._write(currentItem.command);
 
       // *** จุดต่าง: ไม่ resolve ทันที แต่รอให้ _checkQueueExpectations เรียก resolve ***
     } catch (error) {
@@ -408,7 +740,7 @@ class MotorController {
   _finishCommand(item, status, result) {
     // ล้างสถานะ
     this.currentCmdPromise = null;
-    this.currentExpectations = null;
+    this._setExpectations(null);
 
     // แจ้งผลกลับไปที่คนเรียก (await send(...))
     if (status === "error") item.reject(result);
@@ -451,18 +783,40 @@ class MotorController {
     if (cmd.startsWith("a") || cmd.includes(":a"))
       return { type: "ACCEL", codes: [209], count: this._countTargets(cmd) };
     if (cmd.startsWith("i")) return { type: "CONFIG", codes: [300], count: 1 };
+    if (cmd.startsWith("jt")) return { type: "CONFIG", codes: [216], count: 1 };
     
     // --- AUX Tool Commands ---
     // Torom Tool returns: 200 (SUCCESS), 201 (TARGET_REACHED), 100 (INFO)
     // isQueue commands wait for 200/201, non-queue don't wait
     if (cmd.startsWith("m")) return { type: "AUX", codes: [200, 201], count: 1 };
 
+    // --- Input Shaper Commands ---
+    // ต้องเช็คก่อน Info เพราะ "zd" มีตัว d อยู่
+    if (cmd.startsWith("zc") || cmd.includes(":zc"))
+      return { type: "SHAPER_CALIB", codes: [223], count: 1 }; // รอจนวิ่งไป-กลับเสร็จ
+    if (cmd === "z" || cmd.endsWith(":z"))
+      return { type: "SHAPER", codes: [221], count: this._countTargets(cmd) };
+    if (cmd.startsWith("z") || cmd.includes(":z"))
+      return { type: "SHAPER", codes: [220], count: this._countTargets(cmd) };
+
+    // --- Multi-board Sync Commands ---
+    if (cmd === "gq") return { type: "SYNC", codes: [234], count: 1 };
+    if (cmd === "gz" || cmd.startsWith("gp"))
+      return { type: "SYNC", codes: [232], count: 1 };
+    if (cmd === "gc") return { type: "SYNC", codes: [235], count: 1 };
+    if (cmd === "gs" || cmd.startsWith("gt"))
+      return { type: "SYNC", codes: [231], count: 1 };
+    if (cmd === "gg") return { type: "SYNC", codes: [233], count: 1 };
+    if (cmd.startsWith("g") || cmd.includes(":g"))
+      return { type: "ARM", codes: [230], count: this._countTargets(cmd) };
+
     // --- 3. Info Commands ---
     if (cmd.includes("d"))
       return {
         type: "STATUS",
         codes: [200, 201, 202, 203],
         count: this._countTargets(cmd),
+        motors: this._targetMotors(cmd),
       };
     if (cmd.includes("p")) return { type: "POS", codes: [210], count: 1 }; // p returns 1 JSON even for multiple motors
     if (cmd.includes("l"))
@@ -477,6 +831,37 @@ class MotorController {
     return { type: "MOVE", codes: [211], count: this._countTargets(cmd) };
   }
 
+  /**
+   * Set the in-flight expectation and tell the serial worker which lines
+   * must not be dropped from its backlog (anything that can resolve or
+   * reject the command in _checkQueueExpectations). Rules match by code and
+   * source, so motor telemetry stays droppable while an AUX or single-motor
+   * status command is waiting.
+   */
+  _setExpectations(exp) {
+    this.currentExpectations = exp;
+    if (!this.worker) return;
+
+    const rules = [];
+    if (exp) {
+      const codes = [...exp.codes];
+      if (exp.type === "MOVE") codes.push(211, 212, 213);
+      if (exp.type === "SHAPER_CALIB") codes.push(212, 213);
+
+      if (exp.type === "AUX") rules.push({ codes: [...codes, 301], aux: true });
+      else if (exp.type === "STATUS") rules.push({ codes, motors: exp.motors });
+      else rules.push({ codes });
+      rules.push({ codes: [400, 401, 402, 403, 406, 407, 408, 409] });
+    }
+    this.worker.postMessage({ type: "expect", rules });
+  }
+
+  // "1:d" -> ["Motor1"], ไม่มี Prefix -> null (ทุกแกน)
+  _targetMotors(cmd) {
+    const match = cmd.match(/^([1-3]):/);
+    return match ? [`Motor${match[1]}`] : null;
+  }
+
   _countTargets(cmd) {
     // กรณีระบุเป้าหมายชัดเจน เช่น "1:..." -> 1 ตัว
     if (cmd.match(/^[1-3]:/)) return 1;
@@ -0,0 +1,173 @@
+/**
+ * Serial reader / frame parser for MotorController (runs in a Web Worker).
+ *
+ * The main thread transfers port.readable here. This worker decodes chunks,
+ * splits lines, JSON-parses them and posts them back in batches. Only one
+ * batch is in flight at a time: the next one is posted after the main thread
+ * acks the previous one, so a busy UI makes the backlog grow here (bounded)
+ * instead of in the main thread's message queue.
+ */
+
+const FLUSH_INTERVAL_MS = 16; // ~1 frame
+const MAX_LINE_LENGTH = 4096; // Longer partial lines are discarded (line noise / missing "\n")
+
+// Superseded by the next status report, so these are safe to drop under load,
+// except while the command queue is waiting for one of them (see protectRules).
+const TELEMETRY_CODES = new Set([200, 201, 202, 203, 210, 234, 405]);
+
+// Beyond this many times maxBacklog even protected lines are dropped, oldest
+// first, so a telemetry flood during a long status / AUX wait stays bounded.
+const HARD_CAP_FACTOR = 4;
+
+// Lines that can resolve/reject the in-flight queue command, as
+// { codes: Set, motors: [name] | null, aux: bool } rules. The main thread
+// sends them ("expect") before writing the command, so replies always arrive
+// after the update. Matching lines are only dropped past the hard cap.
+let protectRules = [];
+
+let reader = null;
+let decoder = new TextDecoder();
+let buffer = "";
+let backlog = [];
+let maxBacklog = 500;
+let flushTimer = null;
+let batchInFlight = false;
+
+const stats = {
+  lines: 0,
+  parsed: 0,
+  parseErrors: 0,
+  dropped: 0, // telemetry / text lines dropped because the backlog was full
+  overflow: 0, // partial lines dropped for exceeding MAX_LINE_LENGTH
+};
+
+self.onmessage = (e) => {
+  const msg = e.data;
+  switch (msg.type) {
+    case "start":
+      if (msg.maxBacklog) maxBacklog = msg.maxBacklog;
+      readLoop(msg.readable);
+      break;
+    case "expect":
+      protectRules = msg.rules.map((rule) => ({ ...rule, codes: new Set(rule.codes) }));
+      break;
+    case "ack":
+      batchInFlight = false;
+      if (backlog.length > 0) scheduleFlush();
+      break;
+    case "stop":
+      if (reader) reader.cancel().catch(() => {});
+      else self.postMessage({ type: "closed" });
+      break;
+  }
+};
+
+async function readLoop(readable) {
+  decoder = new TextDecoder();
+  buffer = "";
+  reader = readable.getReader();
+  try {
+    while (true) {
+      const { value, done } = await reader.read();
+      if (done) break;
+      handleChunk(decoder.decode(value, { stream: true }));
+    }
+  } catch (error) {
+    self.postMessage({ type: "error", message: String(error) });
+  } finally {
+    reader.releaseLock();
+    reader = null;
+    flush(true);
+    self.postMessage({ type: "closed" });
+  }
+}
+
+function handleChunk(text) {
+  buffer += text;
+  const lines = buffer.split("\n");
+  buffer = lines.pop();
+
+  if (buffer.length > MAX_LINE_LENGTH) {
+    buffer = "";
+    stats.overflow++;
+  }
+
+  for (const line of lines) {
+    const trimmedLine = line.trim();
+    if (trimmedLine === "") continue;
+    stats.lines++;
+
+    const item = { raw: trimmedLine, data: null, telemetry: true };
+    if (trimmedLine.startsWith("{")) {
+      try {
+        item.data = JSON.parse(trimmedLine);
+        item.telemetry = TELEMETRY_CODES.has(item.data.code);
+        stats.parsed++;
+      } catch (e) {
+        item.parseError = true;
+        stats.parseErrors++;
+      }
+    }
+    backlog.push(item);
+  }
+
+  if (backlog.length > maxBacklog) trimBacklog();
+  if (backlog.length > 0) scheduleFlush();
+}
+
+function isProtected(item) {
+  const data = item.data;
+  if (data === null) return false;
+  const motor = data.motor || data.motorName;
+  return protectRules.some((rule) => {
+    if (!rule.codes.has(data.code)) return false;
+    // AUX replies come wrapped (type "AUX") or from the tool without a motor field
+    if (rule.aux) return data.type === "AUX" || !motor;
+    if (rule.motors !== undefined) return !!motor && (rule.motors === null || rule.motors.includes(motor));
+    return true;
+  });
+}
+
+/**
+ * Drop the oldest telemetry / text lines until the backlog fits. If it is
+ * still more than twice the limit (a flood of events), drop the oldest
+ * remaining lines too, but not one the command queue is waiting for unless
+ * the backlog is past the hard cap.
+ */
+function trimBacklog() {
+  backlog = dropOldest(backlog, backlog.length - maxBacklog, (item) => item.telemetry && !isProtected(item));
+  if (backlog.length > maxBacklog * 2) {
+    backlog = dropOldest(backlog, backlog.length - maxBacklog * 2, (item) => !isProtected(item));
+  }
+  if (backlog.length > maxBacklog * HARD_CAP_FACTOR) {
+    backlog = dropOldest(backlog, backlog.length - maxBacklog * HARD_CAP_FACTOR, () => true);
+  }
+}
+
+function dropOldest(items, excess, canDrop) {
+  const kept = [];
+  for (const item of items) {
+    if (excess > 0 && canDrop(item)) {
+      excess--;
+      stats.dropped++;
+      continue;
+    }
+    kept.push(item);
+  }
+  return kept;
+}
+
+function scheduleFlush() {
+  if (flushTimer || batchInFlight) return;
+  flushTimer = setTimeout(() => {
+    flushTimer = null;
+    flush(false);
+  }, FLUSH_INTERVAL_MS);
+}
+
+function flush(force) {
+  if (backlog.length === 0 || (batchInFlight && !force)) return;
+  self.postMessage({ type: "batch", items: backlog, stats: { ...stats } });
+  backlog = [];
+  batchInFlight = true;
+}
@@ -37,6 +37,12 @@ Adafruit_NeoPixel pixels(NUM_PIXELS, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 #define STEP3_PIN 3
 #define DIR3_PIN 8
 
+// --- Multi-board Sync Line ---
+#define SYNC_PIN 4 // สาย Sync ร่วมทุกบอร์ด (Rising edge)
+
+// --- Limit Switch ---
+#define LIMIT_TRIPPED LOW // ระดับขาที่ถือว่ากด/ชนลิมิต (INPUT_PULLUP + สวิตช์ NO) ใช้ทั้ง Trip และ Report
+
 // --- Stepper Driver Configuration ---
 #define R_SENSE 0.11f
 #define SERIAL_ADDRESS 1
@@ -53,12 +59,31 @@ Adafruit_NeoPixel pixels(NUM_PIXELS, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 #define MAX_SPEED STEPS_PER_REVOLUTION*3 
 #define MAX_ACCEL STEPS_PER_REVOLUTION
 
+// --- Input Shaper Configuration ---
+#define SHAPER_SAMPLE_US     500   // ความถี่สุ่มตำแหน่งจาก Planner (2 kHz)
+#define SHAPER_BUFFER_SIZE   512   // ประวัติตำแหน่ง ~256 ms (รองรับความถี่ต่ำสุด)
+#define SHAPER_MIN_FREQ      5.0f
+#define SHAPER_MAX_FREQ      200.0f
+#define SHAPER_DEFAULT_FREQ  40.0f
+#define SHAPER_DEFAULT_ZETA  0.1f
+#define SHAPER_EI_VTOL       0.05f // Vibration tolerance ของ EI shaper
+#define SHAPER_CALIB_DWELL_MS 1000 // เวลารอให้วัดการสั่นหลัง Test move
+
+// --- Sync Clock Configuration ---
+#define SYNC_DEFAULT_PERIOD_US 1000000 // คาบ Sync pulse จาก Host (ค่าเริ่มต้น 1 วินาที)
+#define SYNC_RATE_GAIN 0.1f            // น้ำหนัก EMA ตอนปรับอัตรานาฬิกาตาม Pulse
+
+// --- Jog (Velocity Mode) Configuration ---
+#define JOG_UPDATE_US 1000           // คาบการปรับความเร็ว (ramp) ระหว่าง Jog
+#define JOG_DEFAULT_DEADMAN_MS 300   // ไม่มี keep-alive เกินนี้ -> ชะลอจนหยุด
+
 // ==========================================
 // 2. GLOBAL VARIABLES & ENUMS
 // ==========================================
 
 boolean anyMotorRunning = false;
 float LIMIT_COMPENSATION_RATIO = 1.0f;
+unsigned long JOG_DEADMAN_MS = JOG_DEFAULT_DEADMAN_MS;
 boolean isErrorState = false;
 
 // Enum สำหรับ Report
@@ -91,6 +116,7 @@ void asyncPrint(SerialTarget target, String msg);
 void asyncPrint(SerialTarget target, long num);
 void displayJSON(ReportType type, String message, String motorName = "", int code = 0);
 void displayJSON(ReportType type, String message, int code);
+bool cancelArmedMoves();
 
 // ==========================================
 // 4. TMC DRIVER OBJECTS
@@ -102,13 +128,240 @@ TMC2209Stepper driver2(&Serial1, R_SENSE, SERIAL_ADDRESS_2);
 TMC2209Stepper driver3(&Serial1, R_SENSE, SERIAL_ADDRESS_3);
 
 // ==========================================
-// 5. STEPPER MOTOR CLASS
+// 5. INPUT SHAPER (ZV / ZVD / EI)
+// ==========================================
+// Planner (AccelStepper) สร้างตำแหน่งที่ต้องการ -> Shaper เอามา convolve กับชุด impulse
+// -> Step generator ส่งพัลส์ออกขาตามตำแหน่งที่ผ่านการ shape แล้ว เพื่อหักล้างการสั่นค้าง
+
+class InputShaper {
+public:
+  enum Type { NONE, ZV, ZVD, EI };
+  static const uint8_t MAX_IMPULSES = 3;
+
+private:
+  Type type;
+  float frequency, damping;
+  uint8_t numImpulses;
+  float amplitude[MAX_IMPULSES];
+  float delaySamples[MAX_IMPULSES];
+  long history[SHAPER_BUFFER_SIZE];
+  uint16_t head;                // index ของ sample ล่าสุด
+  uint16_t samplesSinceChange;  // นับ sample ที่ตำแหน่งไม่เปลี่ยน (ใช้เช็คว่านิ่งแล้ว)
+  unsigned long lastSampleUs;
+
+  // ตำแหน่ง Planner ณ (ตอนนี้ - back sample) เทียบกับ live แบบ interpolate
+  // live = ตำแหน่ง ณ ตอนนี้ อยู่ห่างจาก history[head] ไป phase sample (0..1)
+  float at(float back, float phase, long live) {
+    long h = history[head];
+    if (back <= phase) {
+      return phase > 0.0f ? (h - live) * (back / phase) : 0.0f;
+    }
+    float fromHead = back - phase;
+    uint16_t idx = (uint16_t)fromHead;
+    float frac = fromHead - idx;
+    long a = history[(head + SHAPER_BUFFER_SIZE - idx) % SHAPER_BUFFER_SIZE];
+    long b = history[(head + SHAPER_BUFFER_SIZE - idx - 1) % SHAPER_BUFFER_SIZE];
+    return (a - live) + (b - a) * frac;
+  }
+
+public:
+  InputShaper()
+      : type(NONE),
+        frequency(SHAPER_DEFAULT_FREQ),
+        damping(SHAPER_DEFAULT_ZETA),
+        numImpulses(1),
+        head(0),
+        samplesSinceChange(0),
+        lastSampleUs(0) {
+    amplitude[0] = 1.0f;
+    delaySamples[0] = 0.0f;
+    reset(0);
+  }
+
+  // คำนวณชุด impulse ใหม่ คืนค่า false ถ้าพารามิเตอร์ใช้ไม่ได้ (ค่าเดิมไม่ถูกเปลี่ยน)
+  bool configure(Type t, float freq, float zeta) {
+    if (freq < SHAPER_MIN_FREQ || freq > SHAPER_MAX_FREQ) return false;
+    if (zeta < 0.0f || zeta >= 1.0f) return false;
+
+    float root = sqrtf(1.0f - zeta * zeta);
+    float K = expf(-zeta * PI / root);
+    float halfPeriod = 0.5f * 1000000.0f / (freq * root) / SHAPER_SAMPLE_US; // ครึ่งคาบ (หน่วย sample)
+
+    float a[MAX_IMPULSES];
+    uint8_t n;
+    switch (t) {
+      case ZV:
+        a[0] = 1.0f; a[1] = K;
+        n = 2;
+        break;
+      case ZVD:
+        a[0] = 1.0f; a[1] = 2.0f * K; a[2] = K * K;
+        n = 3;
+        break;
+      case EI:
+        a[0] = 0.25f * (1.0f + SHAPER_EI_VTOL);
+        a[1] = 0.5f * (1.0f - SHAPER_EI_VTOL) * K;
+        a[2] = a[0] * K * K;
+        n = 3;
+        break;
+      default:
+        a[0] = 1.0f;
+        n = 1;
+        break;
+    }
+    if ((n - 1) * halfPeriod >= SHAPER_BUFFER_SIZE - 2) return false;
+
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < n; i++) sum += a[i];
+    for (uint8_t i = 0; i < n; i++) {
+      amplitude[i] = a[i] / sum;
+      delaySamples[i] = i * halfPeriod;
+    }
+    numImpulses = n;
+    type = t;
+    frequency = freq;
+    damping = zeta;
+    return true;
+  }
+
+  // ล้างประวัติให้เป็นตำแหน่งเดียวกันทั้งหมด (ใช้ตอน E-Stop / Set Home)
+  void reset(long pos) {
+    for (uint16_t i = 0; i < SHAPER_BUFFER_SIZE; i++) history[i] = pos;
+    samplesSinceChange = SHAPER_BUFFER_SIZE;
+    lastSampleUs = micros();
+  }
+
+  // เก็บตำแหน่งจาก Planner ตามคาบ SHAPER_SAMPLE_US
+  void sample(long plannedPos, unsigned long nowUs) {
+    if (nowUs - lastSampleUs > (unsigned long)SHAPER_SAMPLE_US * SHAPER_BUFFER_SIZE) {
+      lastSampleUs = nowUs - SHAPER_SAMPLE_US; // หลุดไปนานมาก ไม่ต้องไล่เติมทีละช่อง
+    }
+    while (nowUs - lastSampleUs >= SHAPER_SAMPLE_US) {
+      long prev = history[head];
+      head = (head + 1) % SHAPER_BUFFER_SIZE;
+      history[head] = plannedPos;
+      if (plannedPos == prev) {
+        if (samplesSinceChange < SHAPER_BUFFER_SIZE) samplesSinceChange++;
+      } else {
+        samplesSinceChange = 0;
+      }
+      lastSampleUs += SHAPER_SAMPLE_US;
+    }
+  }
+
+  // ประเมินตำแหน่งที่ shape แล้ว ณ เวลาปัจจุบัน (ไม่ใช่แค่ที่ขอบ sample) เพื่อไม่ให้ step
+  // ไปกองอยู่บน grid 500 us -> เรียก sample() ก่อนทุกครั้ง
+  long shapedPosition(long live, unsigned long nowUs) {
+    float phase = (float)(nowUs - lastSampleUs) / SHAPER_SAMPLE_US;
+    if (phase > 1.0f) phase = 1.0f;
+    float offset = 0.0f;
+    for (uint8_t i = 0; i < numImpulses; i++) {
+      offset += amplitude[i] * at(delaySamples[i], phase, live);
+    }
+    return live + lroundf(offset);
+  }
+
+  // true เมื่อ impulse สุดท้ายเห็นตำแหน่งเดียวกับปัจจุบันแล้ว (ไม่มีอะไรค้างในท่อ)
+  bool isSettled() {
+    return samplesSinceChange > delaySamples[numImpulses - 1] + 1;
+  }
+
+  bool isActive() { return type != NONE; }
+  Type getType() { return type; }
+  float getFrequency() { return frequency; }
+  float getDamping() { return damping; }
+
+  static const char* typeName(Type t) {
+    switch (t) {
+      case ZV: return "ZV";
+      case ZVD: return "ZVD";
+      case EI: return "EI";
+      default: return "OFF";
+    }
+  }
+
+  static bool parseType(String name, Type &out) {
+    if (name.equalsIgnoreCase("off")) out = NONE;
+    else if (name.equalsIgnoreCase("zv")) out = ZV;
+    else if (name.equalsIgnoreCase("zvd")) out = ZVD;
+    else if (name.equalsIgnoreCase("ei")) out = EI;
+    else return false;
+    return true;
+  }
+};
+
+// AccelStepper ทำหน้าที่เป็น Planner อย่างเดียวเมื่อเปิด Shaper:
+// step() ถูก override ไม่ให้ยิงพัลส์ แล้ว runOutput() จะเป็นคนยิงพัลส์ตามตำแหน่งที่ shape แล้ว
+class ShapedStepper : public AccelStepper {
+private:
+  uint8_t stepPin, dirPin;
+  long outputPos;
+  int8_t outputDir;
+
+protected:
+  void step(long s) override {
+    if (!shaper.isActive()) AccelStepper::step(s);
+  }
+
+public:
+  InputShaper shaper;
+
+  ShapedStepper(uint8_t stepPin, uint8_t dirPin)
+      : AccelStepper(AccelStepper::DRIVER, stepPin, dirPin),
+        stepPin(stepPin),
+        dirPin(dirPin),
+        outputPos(0),
+        outputDir(0) {}
+
+  // เรียกทุกรอบ loop: ยิงได้ทีละ 1 step ต่อรอบ (ความเร็วหลัง shape ไม่เกินความเร็วที่ Planner สั่ง)
+  void runOutput() {
+    if (!shaper.isActive()) return;
+    unsigned long now = micros();
+    long planned = currentPosition();
+    shaper.sample(planned, now);
+
+    long target = shaper.shapedPosition(planned, now);
+    if (target == outputPos) {
+      if (shaper.isSettled()) outputDir = 0;
+      return;
+    }
+
+    outputDir = target > outputPos ? 1 : -1;
+    digitalWrite(dirPin, outputDir > 0 ? HIGH : LOW);
+    digitalWrite(stepPin, HIGH);
+    delayMicroseconds(1);
+    digitalWrite(stepPin, LOW);
+    outputPos += outputDir;
+  }
+
+  // ให้ Output ตรงกับ Planner ทันที (ทิ้งส่วนที่ค้างใน Shaper)
+  void syncOutput() {
+    outputPos = currentPosition();
+    outputDir = 0;
+    shaper.reset(outputPos);
+  }
+
+  long outputPosition() { return shaper.isActive() ? outputPos : currentPosition(); }
+
+  bool outputSettled() {
+    return !shaper.isActive() || (outputPos == currentPosition() && shaper.isSettled());
+  }
+
+  // ทิศทางที่แกนกำลังเคลื่อนจริง (+1 / -1 / 0) ใช้เช็ค Limit switch
+  int8_t outputDirection() {
+    if (shaper.isActive()) return outputDir;
+    return speed() > 0 ? 1 : (speed() < 0 ? -1 : 0);
+  }
+};
+
+// ==========================================
+// 6. STEPPER MOTOR CLASS
 // ==========================================
 
 class StepperMotor {
 private:
   TMC2209Stepper driver;
-  AccelStepper stepper;
+  ShapedStepper stepper;
   uint8_t enPin;
   uint8_t limitLeftPin;
   uint8_t limitRightPin;
@@ -119,6 +372,116 @@ private:
   bool lastLeftState, lastRightState;
   String motorName;
 
+  // --- Shaper calibration (test move -> dwell -> return) ---
+  enum CalibState { CALIB_IDLE, CALIB_OUT, CALIB_DWELL, CALIB_BACK };
+  volatile CalibState calibState;   // เขียนจาก Core 0 (คำสั่ง) อ่านจาก Core 1 (update)
+  bool calibMotionSeen;             // CALIB_OUT ต้องเห็นแกนขยับก่อน ถึงจะถือว่าถึงปลายทาง
+  long calibStartPos;
+  unsigned long calibMoveStartMs, calibMoveEndMs;
+
+  // --- Armed move (รอ Sync trigger ค่อยออกตัว) ---
+  bool armed;
+  long armedTarget;
+
+  // --- Jog (Velocity Mode) ---
+  bool jogging;
+  float jogTarget, jogSpeed;   // steps/s (มีเครื่องหมาย)
+  unsigned long jogLastKeepaliveMs;
+  unsigned long jogLastUpdateUs;
+
+  // Ramp ความเร็วเข้าหา jogTarget ด้วย maxAccel ทุก JOG_UPDATE_US
+  void updateJog() {
+    unsigned long now = micros();
+    if (now - jogLastUpdateUs < JOG_UPDATE_US) return;
+    float dt = (now - jogLastUpdateUs) * 1e-6f;
+    jogLastUpdateUs = now;
+
+    // Edge detection ใน update() ไม่เห็นสวิตช์ที่ค้างอยู่แล้ว -> เช็คระดับทุกรอบ ramp
+    float heading = jogSpeed != 0 ? jogSpeed : jogTarget;
+    if (heading < 0 && isLeftPressed()) { tripLeft(); return; }
+    if (heading > 0 && isRightPressed()) { tripRight(); return; }
+
+    if (jogTarget != 0 && millis() - jogLastKeepaliveMs > JOG_DEADMAN_MS) {
+      jogTarget = 0;
+      displayJSON(WARNING, "Jog keep-alive timeout - decelerating", motorName, 414);
+    }
+
+    float dv = maxAccel * dt;
+    if (jogSpeed < jogTarget) jogSpeed = min(jogSpeed + dv, jogTarget);
+    else if (jogSpeed > jogTarget) jogSpeed = max(jogSpeed - dv, jogTarget);
+
+    if (jogSpeed == 0 && jogTarget == 0) {
+      endJog();
+      return;
+    }
+    stepper.setSpeed(jogSpeed);
+  }
+
+  void endJog() {
+    jogging = false;
+    jogTarget = 0;
+    jogSpeed = 0;
+    stepper.setSpeed(0);
+    stepper.moveTo(stepper.currentPosition());
+    displayJSON(INFO, "Jog stopped", motorName, 215);
+  }
+
+  void reportShaper(int code) {
+    String output = "{\"motor\":\"";
+    output += motorName;
+    output += "\",\"shaper\":\"";
+    output += InputShaper::typeName(stepper.shaper.getType());
+    output += "\",\"frequency\":";
+    output += String(stepper.shaper.getFrequency(), 2);
+    output += ",\"damping\":";
+    output += String(stepper.shaper.getDamping(), 3);
+    if (code == 223) {
+      output += ",\"moveStartMs\":";
+      output += String(calibMoveStartMs);
+      output += ",\"moveEndMs\":";
+      output += String(calibMoveEndMs);
+    }
+    output += ",\"code\":" + String(code) + "}";
+    asyncPrint(MAIN, output);
+  }
+
+  void updateCalibration() {
+    switch (calibState) {
+      case CALIB_OUT:
+        if (stepper.distanceToGo() != 0 || !stepper.outputSettled()) {
+          calibMotionSeen = true;
+        } else if (calibMotionSeen) {
+          calibMoveEndMs = millis();
+          calibState = CALIB_DWELL;
+        }
+        break;
+      case CALIB_DWELL:
+        if (millis() - calibMoveEndMs >= SHAPER_CALIB_DWELL_MS) {
+          stepper.moveTo(calibStartPos);
+          calibState = CALIB_BACK;
+        }
+        break;
+      case CALIB_BACK:
+        if (stepper.distanceToGo() == 0 && stepper.outputSettled()) {
+          calibState = CALIB_IDLE;
+          reportShaper(223);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  bool applyShaper(InputShaper::Type t, float freq, float zeta) {
+    if (!stepper.shaper.configure(t, freq, zeta)) {
+      displayJSON(ERROR, "Invalid shaper parameters", motorName, 403);
+      return false;
+    }
+    stepper.syncOutput();
+    reportShaper(220);
+    return true;
+  }
+
 public:
   struct Config {
     HardwareSerial &serialPort;
@@ -138,15 +501,27 @@ public:
 
   StepperMotor(const Config &cfg)
       : driver(&cfg.serialPort, cfg.rSense, cfg.serialAddress),
-        stepper(AccelStepper::DRIVER, cfg.stepPin, cfg.dirPin),
+        stepper(cfg.stepPin, cfg.dirPin),
         enPin(cfg.enPin),
         limitLeftPin(cfg.limitLeftPin),
         limitRightPin(cfg.limitRightPin),
         movementComplete(true),
         limitEnabled(cfg.limitLeftPin != 0 || cfg.limitRightPin != 0),
-        lastLeftState(HIGH),
-        lastRightState(HIGH),
-        motorName(cfg.name) {
+        lastLeftState(!LIMIT_TRIPPED),
+        lastRightState(!LIMIT_TRIPPED),
+        motorName(cfg.name),
+        calibState(CALIB_IDLE),
+        calibMotionSeen(false),
+        calibStartPos(0),
+        calibMoveStartMs(0),
+        calibMoveEndMs(0),
+        armed(false),
+        armedTarget(0),
+        jogging(false),
+        jogTarget(0),
+        jogSpeed(0),
+        jogLastKeepaliveMs(0),
+        jogLastUpdateUs(0) {
     pinMode(cfg.enPin, OUTPUT);
     digitalWrite(cfg.enPin, LOW);
 
@@ -183,47 +558,61 @@ public:
       bool leftState = limitLeftPin ? digitalRead(limitLeftPin) : HIGH;
       bool rightState = limitRightPin ? digitalRead(limitRightPin) : HIGH;
 
-      if (limitLeftPin && leftState == HIGH && lastLeftState == LOW) {
-        if (isRunning() && stepper.speed() < 0) {
-          emergencyStop();
-          displayJSON(WARNING, "LEFT LIMIT SWITCH TRIGGERED - STEPPING BACK", motorName,411);
-          stepper.move(STEPS_PER_REVOLUTION * LIMIT_COMPENSATION_RATIO);
-          isErrorState = true;
-          displayPosition();
-        }
+      if (limitLeftPin && leftState == LIMIT_TRIPPED && lastLeftState != LIMIT_TRIPPED) {
+        if (isRunning() && stepper.outputDirection() < 0) tripLeft();
       }
 
-      if (limitRightPin && rightState == HIGH && lastRightState == LOW) {
-        if (isRunning() && stepper.speed() > 0) {
-          emergencyStop();
-          displayJSON(WARNING, "RIGHT LIMIT SWITCH TRIGGERED - STEPPING BACK", motorName,412);
-          stepper.move(-STEPS_PER_REVOLUTION * LIMIT_COMPENSATION_RATIO);
-          isErrorState = true;
-          displayPosition();
-        }
+      if (limitRightPin && rightState == LIMIT_TRIPPED && lastRightState != LIMIT_TRIPPED) {
+        if (isRunning() && stepper.outputDirection() > 0) tripRight();
       }
 
       lastLeftState = leftState;
       lastRightState = rightState;
     }
     
-    if (stepper.distanceToGo() != 0) {
+    if (jogging) {
+      updateJog();
+      if (jogging) stepper.runSpeed(); // updateJog() อาจจบ Jog / ชนลิมิตไปแล้ว
+    } else if (stepper.distanceToGo() != 0) {
       stepper.run();
-    } else if (!movementComplete) {
+    }
+    stepper.runOutput();
+    updateCalibration();
+
+    if (!movementComplete && !isRunning()) {
       movementComplete = true;
       displayJSON(INFO, "Target reached!", motorName,211);
       displayPosition();
     }
   }
 
-  bool isRunning() { return stepper.distanceToGo() != 0; }
+  bool isRunning() {
+    return jogging || stepper.distanceToGo() != 0 || !stepper.outputSettled() || calibState != CALIB_IDLE;
+  }
+
+  void tripLeft() {
+    emergencyStop();
+    displayJSON(WARNING, "LEFT LIMIT SWITCH TRIGGERED - STEPPING BACK", motorName,411);
+    stepper.move(STEPS_PER_REVOLUTION * LIMIT_COMPENSATION_RATIO);
+    isErrorState = true;
+    displayPosition();
+  }
+
+  void tripRight() {
+    emergencyStop();
+    displayJSON(WARNING, "RIGHT LIMIT SWITCH TRIGGERED - STEPPING BACK", motorName,412);
+    stepper.move(-STEPS_PER_REVOLUTION * LIMIT_COMPENSATION_RATIO);
+    isErrorState = true;
+    displayPosition();
+  }
 
+  // นิยามเดียวกับที่ update() ใช้ตัดสินว่าชนลิมิต (ใช้ทั้ง Report / Jog)
   bool isLeftPressed() {
-    return limitLeftPin && digitalRead(limitLeftPin) == LOW;
+    return limitLeftPin && digitalRead(limitLeftPin) == LIMIT_TRIPPED;
   }
 
   bool isRightPressed() {
-    return limitRightPin && digitalRead(limitRightPin) == LOW;
+    return limitRightPin && digitalRead(limitRightPin) == LIMIT_TRIPPED;
   }
 
   void printLimitStatus() {
@@ -243,19 +632,27 @@ public:
   }
 
   void stop() {
-    stepper.stop();
+    calibState = CALIB_IDLE;
+    if (jogging) jogTarget = 0; // ให้ ramp ชะลอลงเอง
+    else stepper.stop();
     displayJSON(INFO, "Motor stopped (decelerating)", motorName,212);
   }
 
   void emergencyStop() {
-    stepper.setCurrentPosition(stepper.currentPosition());
+    calibState = CALIB_IDLE;
+    cancelArmedMoves(); // E-Stop / ชนลิมิต ต้องไม่ให้ Sync trigger มาออกตัวทีหลัง
+    jogging = false;
+    jogTarget = 0;
+    jogSpeed = 0;
+    stepper.setCurrentPosition(stepper.outputPosition());
+    stepper.syncOutput();
     displayJSON(INFO, "Emergency stop executed", motorName,213);
   }
 
-  long getCurrentPosition() { return stepper.currentPosition(); }
+  long getCurrentPosition() { return stepper.outputPosition(); }
 
   void displayPosition() {
-    long pos = stepper.currentPosition();
+    long pos = stepper.outputPosition();
     String output = "{\"motor\":\"";
     output += motorName;
     output += "\",\"position\":";
@@ -286,6 +683,7 @@ public:
 
   void setHome() {
     stepper.setCurrentPosition(0);
+    stepper.syncOutput();
     displayJSON(INFO, "Home position set", motorName, 206);
   }
 
@@ -300,19 +698,362 @@ public:
   }
   
   void setSpeed(float speed) { 
-    stepper.setMaxSpeed(speed*stepsPerRev); 
+    maxSpeed = speed*stepsPerRev;
+    stepper.setMaxSpeed(maxSpeed); 
     displayJSON(INFO, "Max speed set to: " + String(speed), motorName, 205);
   }
   
   void setAcceleration(float accel) { 
-    stepper.setAcceleration(accel*stepsPerRev); 
+    maxAccel = accel*stepsPerRev;
+    stepper.setAcceleration(maxAccel); 
     displayJSON(INFO, "Acceleration set to: " + String(accel), motorName, 209);
   }
+
+  void setShaperType(InputShaper::Type t) {
+    applyShaper(t, stepper.shaper.getFrequency(), stepper.shaper.getDamping());
+  }
+
+  void setShaperFrequency(float freq) {
+    applyShaper(stepper.shaper.getType(), freq, stepper.shaper.getDamping());
+  }
+
+  void setShaperDamping(float zeta) {
+    applyShaper(stepper.shaper.getType(), stepper.shaper.getFrequency(), zeta);
+  }
+
+  void printShaperStatus() { reportShaper(221); }
+
+  // Test move สำหรับวัดการสั่น: วิ่งไป steps -> หยุดรอ SHAPER_CALIB_DWELL_MS -> กลับจุดเดิม
+  // จบแล้วรายงานเวลา (millis) ของช่วงวิ่ง ให้ Host เอาไปเทียบกับข้อมูลจาก Accelerometer
+  void startShaperCalibration(long steps) {
+    if (steps == 0) {
+      displayJSON(ERROR, "Calibration move requires non-zero steps", motorName, 403);
+      return;
+    }
+    calibStartPos = stepper.outputPosition();
+    calibMoveStartMs = millis();
+    calibMoveEndMs = 0;
+    calibMotionSeen = false;
+    // สั่ง move ก่อนเปลี่ยน state: Core 1 จะได้ไม่เห็น CALIB_OUT ตอนแกนยังนิ่งอยู่
+    move(steps);
+    calibState = CALIB_OUT;
+    reportShaper(222);
+  }
+
+  // Velocity mode: speed หน่วย rev/s (มีเครื่องหมาย) เปลี่ยนความเร็ว/ทิศได้ระหว่างวิ่ง
+  // ทุกครั้งที่เรียกนับเป็น keep-alive ด้วย
+  // การปฏิเสธ Jog ใช้ 413/416 (ไม่ใช่ 406) เพื่อไม่ให้ไปปน reply ของคำสั่งในคิวฝั่ง Host
+  void jog(float speed) {
+    float target = constrain(speed * stepsPerRev, -maxSpeed, maxSpeed);
+    if (target == 0) {
+      // j0 ต้อง idempotent: ไม่ได้ Jog อยู่ก็ตอบ 215 เสมอ (Host ใช้ยืนยันการหยุด)
+      if (!jogging) {
+        displayJSON(INFO, "Jog stopped", motorName, 215);
+        return;
+      }
+      jogTarget = 0;
+      jogLastKeepaliveMs = millis();
+      return;
+    }
+    if ((target < 0 && isLeftPressed()) || (target > 0 && isRightPressed())) {
+      displayJSON(ERROR, "Jog blocked by limit switch", motorName, 413);
+      return;
+    }
+    if (!jogging) {
+      if (isRunning()) {
+        displayJSON(ERROR, "Cannot jog while a move is running.", motorName, 416);
+        return;
+      }
+      jogSpeed = 0;
+      jogLastUpdateUs = micros();
+      movementComplete = false;
+      jogging = true;
+      displayJSON(INFO, "Jog started", motorName, 214);
+    }
+    jogTarget = target;
+    jogLastKeepaliveMs = millis();
+  }
+
+  void keepAlive() { jogLastKeepaliveMs = millis(); }
+
+  // Preload เป้าหมาย (Absolute) ไว้ก่อน ยังไม่วิ่งจนกว่าจะถูก trigger
+  void arm(long target) {
+    armedTarget = target;
+    armed = true;
+    displayJSON(INFO, "Move armed to " + String(target), motorName, 230);
+  }
+
+  void disarm() { armed = false; }
+
+  bool isArmed() { return armed; }
+
+  // เรียกจาก loop() (Core 1) ตอน trigger: ออกตัวทันที ไม่ report เพื่อไม่ให้หน่วง
+  bool fireArmed() {
+    if (!armed) return false;
+    armed = false;
+    moveTo(armedTarget);
+    return true;
+  }
+
   String getName() { return motorName; }
 };
 
 // ==========================================
-// 6. MOTOR INSTANCES CONFIGURATION
+// 7. MULTI-BOARD MOTION SYNC
+// ==========================================
+// หลายบอร์ดใช้สาย Sync ร่วมกัน: Host ยิง Pulse เป็นคาบคงที่ -> แต่ละบอร์ดปรับนาฬิกาของตัวเอง
+// ให้ตรงกับ Pulse (Sync clock) แล้ว Move ที่ armed ไว้จะออกตัวที่ edge ถัดไป หรือที่เวลา Sync ที่นัดไว้
+
+portMUX_TYPE syncMux = portMUX_INITIALIZER_UNLOCKED;
+volatile int64_t syncEdgeUs = 0;
+volatile uint32_t syncEdgeCount = 0;
+
+void IRAM_ATTR onSyncEdge() {
+  portENTER_CRITICAL_ISR(&syncMux);
+  syncEdgeUs = esp_timer_get_time();
+  syncEdgeCount++;
+  portEXIT_CRITICAL_ISR(&syncMux);
+}
+
+class MotionSync {
+public:
+  enum Trigger { TRIG_NONE, TRIG_EDGE, TRIG_TIME, TRIG_NOW };
+
+private:
+  // สถานะนาฬิกา Sync: Core 1 เขียน (discipline) / Core 0 อ่าน (คำสั่ง g..)
+  // ค่า 64-bit อ่าน/เขียนไม่ atomic บน Xtensa -> เข้าถึงผ่าน syncMux เท่านั้น
+  struct Clock {
+    bool valid;
+    int64_t edgeLocalUs;   // เวลา local (esp_timer) ของ Pulse ล่าสุด
+    int64_t edgeSyncUs;    // เวลา Sync ของ Pulse ล่าสุด
+    float localPeriodUs;   // คาบ Pulse ที่วัดด้วยนาฬิกาของบอร์ดนี้ (ใช้ชดเชย drift)
+  };
+
+  Clock clock;
+  Trigger trigger;
+  bool epochPending;
+  int64_t scheduledSyncUs;
+  int64_t requestedUs;       // เวลาที่สั่ง gg (ใช้คำนวณ skew ของ TRIG_NOW)
+  uint32_t periodUs;         // คาบ Pulse ตามที่ Host ตั้งไว้
+  long lastPhaseErrorUs;
+  uint32_t seenEdges;        // ใช้บน Core 1 อย่างเดียว
+
+  Clock snapshot() {
+    portENTER_CRITICAL(&syncMux);
+    Clock c = clock;
+    portEXIT_CRITICAL(&syncMux);
+    return c;
+  }
+
+  int64_t toSync(const Clock &c, int64_t localUs) {
+    return c.edgeSyncUs + (int64_t)((localUs - c.edgeLocalUs) * (double)periodUs / c.localPeriodUs);
+  }
+
+  int64_t toLocal(const Clock &c, int64_t syncUs) {
+    return c.edgeLocalUs + (int64_t)((syncUs - c.edgeSyncUs) * (double)c.localPeriodUs / periodUs);
+  }
+
+  // คำนวณนอก critical section แล้วค่อยเขียนกลับใต้ lock (ห้ามเรียก displayJSON ตอนถือ lock)
+  void discipline(int64_t edgeUs) {
+    portENTER_CRITICAL(&syncMux);
+    bool setEpoch = epochPending;
+    epochPending = false;
+    portEXIT_CRITICAL(&syncMux);
+
+    if (setEpoch) {
+      Clock c = { true, edgeUs, 0, (float)periodUs };
+      portENTER_CRITICAL(&syncMux);
+      clock = c;
+      lastPhaseErrorUs = 0;
+      portEXIT_CRITICAL(&syncMux);
+      displayJSON(INFO, "Sync clock epoch set", 236);
+      return;
+    }
+
+    Clock c = snapshot();
+    if (!c.valid) return;
+
+    int64_t elapsed = edgeUs - c.edgeLocalUs;
+    long periods = lroundf(elapsed / c.localPeriodUs);
+    if (periods < 1) return; // Glitch / สัญญาณเด้ง ไม่นับ
+
+    long phaseError = (long)(elapsed - (int64_t)(periods * c.localPeriodUs));
+    c.localPeriodUs += SYNC_RATE_GAIN * ((float)elapsed / periods - c.localPeriodUs);
+    c.edgeLocalUs = edgeUs;
+    c.edgeSyncUs += (int64_t)periods * periodUs;
+
+    portENTER_CRITICAL(&syncMux);
+    if (clock.valid && !epochPending) clock = c; // gz อาจถูกสั่งระหว่างคำนวณ
+    lastPhaseErrorUs = phaseError;
+    portEXIT_CRITICAL(&syncMux);
+  }
+
+public:
+  MotionSync()
+      : clock{ false, 0, 0, (float)SYNC_DEFAULT_PERIOD_US },
+        trigger(TRIG_NONE),
+        epochPending(false),
+        scheduledSyncUs(0),
+        requestedUs(0),
+        periodUs(SYNC_DEFAULT_PERIOD_US),
+        lastPhaseErrorUs(0),
+        seenEdges(0) {}
+
+  void begin() {
+    pinMode(SYNC_PIN, INPUT_PULLDOWN);
+    attachInterrupt(digitalPinToInterrupt(SYNC_PIN), onSyncEdge, RISING);
+  }
+
+  // เรียกทุกรอบ loop() คืน Trigger ที่ทำงาน (TRIG_NONE = ยังไม่ถึงเวลา)
+  // referenceUs = เวลา local ที่ควรออกตัวจริง ใช้วัด skew
+  Trigger update(int64_t &referenceUs) {
+    portENTER_CRITICAL(&syncMux);
+    uint32_t edges = syncEdgeCount;
+    int64_t edgeUs = syncEdgeUs;
+    Trigger armed = trigger;
+    int64_t scheduled = scheduledSyncUs;
+    int64_t requested = requestedUs;
+    portEXIT_CRITICAL(&syncMux);
+
+    Trigger fired = TRIG_NONE;
+    if (edges != seenEdges) {
+      seenEdges = edges;
+      if (armed == TRIG_EDGE) {
+        // Edge ที่ใช้ Start ไม่ได้มาตามคาบ จึงไม่เอาไปปรับนาฬิกา
+        fired = TRIG_EDGE;
+        referenceUs = edgeUs;
+      } else {
+        discipline(edgeUs);
+      }
+    }
+
+    if (fired == TRIG_NONE && armed == TRIG_TIME) {
+      Clock c = snapshot();
+      if (c.valid) {
+        int64_t startLocal = toLocal(c, scheduled);
+        if (esp_timer_get_time() >= startLocal) {
+          fired = TRIG_TIME;
+          referenceUs = startLocal;
+        }
+      }
+    }
+
+    if (fired == TRIG_NONE && armed == TRIG_NOW) {
+      fired = TRIG_NOW;
+      referenceUs = requested;
+    }
+
+    if (fired != TRIG_NONE) {
+      // ยิงเฉพาะเมื่อ trigger ยังเป็นตัวเดิม (ไม่ถูก gc / e / s ยกเลิกไประหว่างนี้)
+      portENTER_CRITICAL(&syncMux);
+      bool stillArmed = trigger == armed;
+      if (stillArmed) trigger = TRIG_NONE;
+      portEXIT_CRITICAL(&syncMux);
+      if (!stillArmed) fired = TRIG_NONE;
+    }
+    return fired;
+  }
+
+  void armEdge() {
+    portENTER_CRITICAL(&syncMux);
+    trigger = TRIG_EDGE;
+    portEXIT_CRITICAL(&syncMux);
+    displayJSON(INFO, "Armed: start on next sync edge", 231);
+  }
+
+  bool armAt(int64_t syncUs) {
+    Clock c = snapshot();
+    if (!c.valid) {
+      displayJSON(ERROR, "Sync clock not established (send gz and sync pulses first)", 408);
+      return false;
+    }
+    if (syncUs <= toSync(c, esp_timer_get_time())) {
+      displayJSON(ERROR, "Scheduled sync time already passed", 408);
+      return false;
+    }
+    portENTER_CRITICAL(&syncMux);
+    scheduledSyncUs = syncUs;
+    trigger = TRIG_TIME;
+    portEXIT_CRITICAL(&syncMux);
+    displayJSON(INFO, "Armed: start at sync time " + String(syncUs), 231);
+    return true;
+  }
+
+  void armNow() {
+    portENTER_CRITICAL(&syncMux);
+    requestedUs = esp_timer_get_time();
+    trigger = TRIG_NOW;
+    portEXIT_CRITICAL(&syncMux);
+  }
+
+  // คืนค่า true ถ้ามี trigger ค้างอยู่แล้วถูกยกเลิก
+  bool cancel() {
+    portENTER_CRITICAL(&syncMux);
+    bool wasArmed = trigger != TRIG_NONE;
+    trigger = TRIG_NONE;
+    portEXIT_CRITICAL(&syncMux);
+    return wasArmed;
+  }
+
+  static const char* triggerName(Trigger t) {
+    switch (t) {
+      case TRIG_EDGE: return "EDGE";
+      case TRIG_TIME: return "TIME";
+      case TRIG_NOW: return "NOW";
+      default: return "NONE";
+    }
+  }
+
+  // Pulse ถัดไปบนสาย Sync จะเป็นเวลา 0 ของ Sync clock (แจ้งด้วย 236 ตอน Pulse มาถึง)
+  // Trigger ที่ค้างอยู่ต้องถูกยกเลิกก่อน (processCommand เรียก cancelArmedMoves())
+  void zeroOnNextEdge() {
+    portENTER_CRITICAL(&syncMux);
+    clock.valid = false;
+    epochPending = true;
+    portEXIT_CRITICAL(&syncMux);
+    displayJSON(INFO, "Sync clock will zero on next sync edge", 232);
+  }
+
+  void setPeriod(uint32_t us) {
+    portENTER_CRITICAL(&syncMux);
+    periodUs = us;
+    clock.localPeriodUs = us;
+    portEXIT_CRITICAL(&syncMux);
+    displayJSON(INFO, "Sync pulse period set to " + String(us) + " us", 232);
+  }
+
+  bool isClockValid() { return snapshot().valid; }
+
+  int64_t localToSync(int64_t localUs) { return toSync(snapshot(), localUs); }
+
+  void printStatus() {
+    Clock c = snapshot();
+    portENTER_CRITICAL(&syncMux);
+    Trigger armed = trigger;
+    long phaseError = lastPhaseErrorUs;
+    portEXIT_CRITICAL(&syncMux);
+
+    String output = "{\"clockValid\":";
+    output += c.valid ? "true" : "false";
+    output += ",\"syncTimeUs\":";
+    output += c.valid ? String(toSync(c, esp_timer_get_time())) : String("null");
+    output += ",\"periodUs\":";
+    output += String(periodUs);
+    output += ",\"driftPpm\":";
+    output += String((c.localPeriodUs - periodUs) * 1000000.0f / periodUs, 1);
+    output += ",\"phaseErrorUs\":";
+    output += String(phaseError);
+    output += ",\"trigger\":\"";
+    output += triggerName(armed);
+    output += "\",\"code\":234}";
+    asyncPrint(MAIN, output);
+  }
+};
+
+MotionSync motionSync;
+
+// ==========================================
+// 8. MOTOR INSTANCES CONFIGURATION
 // ==========================================
 
 StepperMotor::Config M1 = {
@@ -363,7 +1104,7 @@ StepperMotor motorY(M2);
 StepperMotor motorZ(M3);
 
 // ==========================================
-// 7. HELPER FUNCTIONS IMPLEMENTATION
+// 9. HELPER FUNCTIONS IMPLEMENTATION
 // ==========================================
 
 // ฟังก์ชัน asyncPrint ตัวจริง
@@ -415,6 +1156,40 @@ void displayJSON(ReportType type, String message, String motorName, int code) {
 void displayJSON(ReportType type, String message, int code) {
     displayJSON(type, message, "", code);
 }
+bool anyMotorArmed() {
+  return motorX.isArmed() || motorY.isArmed() || motorZ.isArmed();
+}
+
+// ยกเลิก Sync trigger และ armed move ทุกแกน คืนค่า true ถ้ามีอะไรถูกยกเลิก
+bool cancelArmedMoves() {
+  bool cancelled = motionSync.cancel() || anyMotorArmed();
+  motorX.disarm(); motorY.disarm(); motorZ.disarm();
+  return cancelled;
+}
+
+// ออกตัวทุกแกนที่ armed ไว้พร้อมกัน แล้วรายงาน skew (เวลาออกตัวจริง - เวลาที่ควรออกตัว)
+void startArmedMoves(MotionSync::Trigger trigger, int64_t referenceUs) {
+  bool started = motorX.fireArmed();
+  started |= motorY.fireArmed();
+  started |= motorZ.fireArmed();
+  int64_t startUs = esp_timer_get_time();
+
+  if (!started) {
+    // แจ้งแบบ async จาก Core 1 -> ใช้ code แยกจาก 409 (ที่เป็น reply ของคำสั่ง)
+    displayJSON(WARNING, "Sync trigger fired but no move was armed", 237);
+    return;
+  }
+
+  String output = "{\"trigger\":\"";
+  output += MotionSync::triggerName(trigger);
+  output += "\",\"startSyncUs\":";
+  output += motionSync.isClockValid() ? String(motionSync.localToSync(startUs)) : String("null");
+  output += ",\"skewUs\":";
+  output += String((long)(startUs - referenceUs));
+  output += ",\"code\":233}";
+  asyncPrint(MAIN, output);
+}
+
 // ฟังก์ชัน processCommand
 void processCommand(String input, boolean motorStatus) {
   input.trim();
@@ -437,17 +1212,29 @@ void processCommand(String input, boolean motorStatus) {
   }
 
   if (command.equalsIgnoreCase("s")) {
-    if(!motorStatus) { displayJSON(ERROR, "Nothing to stop, motors are idle.",406); return; }
+    // Stop ยกเลิก armed move เสมอ แม้มอเตอร์จะยังนิ่งอยู่
+    bool cancelled = cancelArmedMoves();
+    if(!motorStatus) {
+      if (cancelled) displayJSON(INFO, "Armed moves cancelled", 235);
+      else displayJSON(ERROR, "Nothing to stop, motors are idle.",406);
+      return;
+    }
     if (bothMotors) { motorX.stop(); motorY.stop(); motorZ.stop(); }
     else targetMotor->stop();
   }
   else if (command.equalsIgnoreCase("e")) {
-    if(!motorStatus) { displayJSON(ERROR, "Nothing to emergency stop, motors are idle.",407); return; }
+    bool cancelled = cancelArmedMoves();
+    if(!motorStatus) {
+      if (cancelled) displayJSON(INFO, "Armed moves cancelled", 235);
+      else displayJSON(ERROR, "Nothing to emergency stop, motors are idle.",407);
+      return;
+    }
     if (bothMotors) { motorX.emergencyStop(); motorY.emergencyStop(); motorZ.emergencyStop(); }
     else targetMotor->emergencyStop();
   }
   else if (command.equalsIgnoreCase("h")) {
     if(motorStatus) { displayJSON(ERROR, "Cannot set home while motors are running.",406); return; }
+    if(anyMotorArmed()) { displayJSON(ERROR, "Cannot set home while a move is armed (send gc to cancel).",406); return; }
     if (bothMotors) { motorX.setHome(); motorY.setHome(); motorZ.setHome(); }
     else targetMotor->setHome();
   }
@@ -499,6 +1286,97 @@ void processCommand(String input, boolean motorStatus) {
     if (bothMotors) { motorX.printLimitStatus(); motorY.printLimitStatus(); motorZ.printLimitStatus(); }
     else targetMotor->printLimitStatus();
   }
+  else if (command.equalsIgnoreCase("z")) {
+    if (bothMotors) { motorX.printShaperStatus(); motorY.printShaperStatus(); motorZ.printShaperStatus(); }
+    else targetMotor->printShaperStatus();
+  }
+  else if (command.startsWith("zt")) {
+    if(motorStatus) { displayJSON(ERROR, "Cannot change input shaper while motors are running.",406); return; }
+    InputShaper::Type type;
+    if (!InputShaper::parseType(command.substring(2), type)) {
+      displayJSON(ERROR, "Unknown shaper type (use off, zv, zvd, ei)", 403);
+      return;
+    }
+    if (bothMotors) { motorX.setShaperType(type); motorY.setShaperType(type); motorZ.setShaperType(type); }
+    else targetMotor->setShaperType(type);
+  }
+  else if (command.startsWith("zf")) {
+    if(motorStatus) { displayJSON(ERROR, "Cannot change input shaper while motors are running.",406); return; }
+    float freq = command.substring(2).toFloat();
+    if (bothMotors) { motorX.setShaperFrequency(freq); motorY.setShaperFrequency(freq); motorZ.setShaperFrequency(freq); }
+    else targetMotor->setShaperFrequency(freq);
+  }
+  else if (command.startsWith("zd")) {
+    if(motorStatus) { displayJSON(ERROR, "Cannot change input shaper while motors are running.",406); return; }
+    float zeta = command.substring(2).toFloat();
+    if (bothMotors) { motorX.setShaperDamping(zeta); motorY.setShaperDamping(zeta); motorZ.setShaperDamping(zeta); }
+    else targetMotor->setShaperDamping(zeta);
+  }
+  else if (command.startsWith("zc") && targetMotor) {
+    if(motorStatus) { displayJSON(ERROR, "Cannot start calibration move while motors are running.",406); return; }
+    if(anyMotorArmed()) { displayJSON(ERROR, "Cannot start calibration move while a move is armed (send gc to cancel).",406); return; }
+    targetMotor->startShaperCalibration(command.substring(2).toInt());
+  }
+  else if (command.startsWith("jt")) {
+    long timeout = command.substring(2).toInt();
+    if (timeout <= 0) { displayJSON(ERROR, "Jog timeout must be positive", 403); return; }
+    JOG_DEADMAN_MS = timeout;
+    displayJSON(INFO, "Jog keep-alive timeout set to: " + String(JOG_DEADMAN_MS) + " ms", 216);
+  }
+  else if (command.startsWith("j")) {
+    // ไม่เช็ค motorStatus: Jog ต้องเปลี่ยนความเร็วได้ระหว่างวิ่ง
+    if (!targetMotor) { displayJSON(ERROR, "Jog requires a motor prefix (e.g. 1:j0.5)", 403); return; }
+    float speed = command.substring(1).toFloat();
+    if(speed != 0 && anyMotorArmed()) { displayJSON(ERROR, "Cannot jog while a move is armed (send gc to cancel).", targetMotor->getName(), 416); return; }
+    targetMotor->jog(speed);
+  }
+  else if (command.equalsIgnoreCase("k")) {
+    if (bothMotors) { motorX.keepAlive(); motorY.keepAlive(); motorZ.keepAlive(); }
+    else targetMotor->keepAlive();
+  }
+  else if (command.equalsIgnoreCase("gq")) {
+    motionSync.printStatus();
+  }
+  else if (command.equalsIgnoreCase("gz")) {
+    // นาฬิกาเริ่มใหม่ -> เวลาที่นัดไว้ไม่มีความหมายแล้ว ยกเลิก armed move ทั้งหมดด้วย
+    if (cancelArmedMoves()) displayJSON(INFO, "Armed moves cancelled", 235);
+    motionSync.zeroOnNextEdge();
+  }
+  else if (command.startsWith("gp")) {
+    long period = command.substring(2).toInt();
+    if (period < 1000) { displayJSON(ERROR, "Sync pulse period must be at least 1000 us", 403); return; }
+    motionSync.setPeriod(period);
+  }
+  else if (command.equalsIgnoreCase("gc")) {
+    cancelArmedMoves();
+    displayJSON(INFO, "Armed moves cancelled", 235);
+  }
+  else if (command.equalsIgnoreCase("gs") || command.startsWith("gt") || command.equalsIgnoreCase("gg")) {
+    if(motorStatus) { displayJSON(ERROR, "Cannot arm sync start while motors are running.",406); return; }
+    if(!anyMotorArmed()) { displayJSON(ERROR, "No move armed", 409); return; }
+    if (command.equalsIgnoreCase("gs")) motionSync.armEdge();
+    else if (command.equalsIgnoreCase("gg")) motionSync.armNow();
+    else motionSync.armAt(strtoll(command.substring(2).c_str(), NULL, 10));
+  }
+  else if (command.startsWith("g")) {
+    if(motorStatus) { displayJSON(ERROR, "Cannot arm moves while motors are running.",406); return; }
+    String targets = command.substring(1);
+    if (targetMotor) {
+      targetMotor->arm(targets.toInt());
+    } else {
+      int commaIndex = targets.indexOf(",");
+      if (commaIndex == -1) { displayJSON(ERROR, "Both motors command requires comma-separated values", 403); return; }
+      String remaining = targets.substring(commaIndex + 1);
+      int secondCommaIndex = remaining.indexOf(",");
+      motorX.arm(targets.substring(0, commaIndex).toInt());
+      if (secondCommaIndex != -1) {
+        motorY.arm(remaining.substring(0, secondCommaIndex).toInt());
+        motorZ.arm(remaining.substring(secondCommaIndex + 1).toInt());
+      } else {
+        motorY.arm(remaining.toInt());
+      }
+    }
+  }
   else if (command.equalsIgnoreCase("on")) {
     if(motorStatus) { displayJSON(ERROR, "Motors are already running.",406); return; }
     if (bothMotors) { motorX.enable(); motorY.enable(); motorZ.enable(); }
@@ -511,18 +1389,22 @@ void processCommand(String input, boolean motorStatus) {
   }
   else if (command.startsWith("+") && targetMotor) {
     if(motorStatus) { displayJSON(ERROR, "Cannot move motors while they are running.",406); return; }
+    if(anyMotorArmed()) { displayJSON(ERROR, "Cannot move motors while a move is armed (send gc to cancel).",406); return; }
     targetMotor->move(command.substring(1).toInt());
   }
   else if (command.startsWith("-") && targetMotor) {
     if(motorStatus) { displayJSON(ERROR, "Cannot move motors while they are running.",406); return; }
+    if(anyMotorArmed()) { displayJSON(ERROR, "Cannot move motors while a move is armed (send gc to cancel).",406); return; }
     targetMotor->move(command.toInt());
   }
   else if (command.length() > 0 && targetMotor) {
     if(motorStatus) { displayJSON(ERROR, "Cannot move motors while they are running.",406); return; }
+    if(anyMotorArmed()) { displayJSON(ERROR, "Cannot move motors while a move is armed (send gc to cancel).",406); return; }
     targetMotor->moveTo(command.toInt());
   }
   else if (command.length() > 0 && bothMotors) {
     if(motorStatus) { displayJSON(ERROR, "Cannot move motors while they are running.",406); return; }
+    if(anyMotorArmed()) { displayJSON(ERROR, "Cannot move motors while a move is armed (send gc to cancel).",406); return; }
     int commaIndex = command.indexOf(",");
     if(commaIndex != -1){
       String cmdX = command.substring(0, commaIndex);
@@ -550,7 +1432,7 @@ void processCommand(String input, boolean motorStatus) {
 }
 
 // ==========================================
-// 8. CORE 0 TASK (SERIAL WORKER)
+// 10. CORE 0 TASK (SERIAL WORKER)
 // ==========================================
 
 void SerialTask(void * parameter) {
@@ -633,7 +1515,7 @@ void SerialTask(void * parameter) {
 }
 
 // ==========================================
-// 9. SETUP & LOOP
+// 11. SETUP & LOOP
 // ==========================================
 
 
@@ -662,6 +1544,9 @@ void setup() {
   pinMode(EN_PIN, OUTPUT);
   digitalWrite(EN_PIN, LOW); 
 
+  // สาย Sync (Interrupt อยู่บน Core 1 เดียวกับ loop)
+  motionSync.begin();
+
   // 4. Setup TMC (Core 1 ทำหน้าที่ Setup HW หลัก)
   Serial1.begin(115200, SERIAL_8N1, RXD1_PIN, TXD1_PIN);
   
@@ -694,6 +1579,11 @@ void setup() {
 }
 
 void loop() {
+  // Sync trigger มาก่อน เพื่อให้ออกตัวได้ใน loop รอบเดียวกัน
+  int64_t syncReferenceUs;
+  MotionSync::Trigger fired = motionSync.update(syncReferenceUs);
+  if (fired != MotionSync::TRIG_NONE) startArmedMoves(fired, syncReferenceUs);
+
   // Priority สูงสุด: สั่งมอเตอร์ทำงาน (Run ที่ Core 1)
   motorX.update();
   motorY.update();